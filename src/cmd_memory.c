@@ -0,0 +1,359 @@
+#include "cmd_memory.h"
+
+#include <lib/xboxkrnl/xboxkrnl.h>
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+
+#include "command_processor_util.h"
+
+static const uint32_t kTag = 0x74726E72;  // 'trnr'
+
+#define kMaxBatchEntries 64
+#define kMaxPeekSize 256
+#define kMaxWatchLists 16
+#define kPageSize 4096
+
+// Describes a single address in a peek or poke batch.
+typedef struct BatchEntry {
+  intptr_t address;
+  uint32_t size;
+  // The value to be written by a poke operation. Unused by peek.
+  uint32_t value;
+} BatchEntry;
+
+// A stored set of addresses that may be peeked by ID.
+typedef struct WatchList {
+  uint32_t num_entries;
+  BatchEntry *entries;
+} WatchList;
+
+static WatchList watch_lists[kMaxWatchLists] = {0};
+
+static HRESULT ParseBatchEntries(CommandParameters *cp, BOOL with_values,
+                                 BatchEntry **entries, uint32_t *num_entries,
+                                 char *response, DWORD response_len);
+static HRESULT SendPeekResponse(const BatchEntry *entries, uint32_t num_entries,
+                                char *response, DWORD response_len,
+                                CommandContext *ctx);
+static HRESULT_API SendPeekData(CommandContext *ctx, char *response,
+                                DWORD response_len);
+static BOOL IsRangeAccessible(intptr_t address, uint32_t size, BOOL writable);
+static void FreeWatchList(WatchList *list);
+
+HRESULT HandlePeek(const char *command, char *response, DWORD response_len,
+                   CommandContext *ctx) {
+  CommandParameters cp;
+  int32_t result = CPParseCommandParameters(command, &cp);
+  if (result < 0) {
+    return CPPrintError(result, response, response_len);
+  }
+
+  uint32_t list_id;
+  bool list_found = CPGetUInt32("list", &list_id, &cp);
+  bool clear = CPHasKey("clear", &cp);
+
+  BatchEntry *entries = NULL;
+  uint32_t num_entries = 0;
+  HRESULT ret = ParseBatchEntries(&cp, FALSE, &entries, &num_entries,
+                                  response, response_len);
+  CPDelete(&cp);
+  if (ret != XBOX_S_OK) {
+    return ret;
+  }
+
+  if (!list_found) {
+    if (!num_entries) {
+      *response = 0;
+      strncat(response,
+              "Missing required parameters.\n"
+              "  addr<N>=<address> [size<N>=<bytes>] - Read the given "
+              "addresses, N = 0, 1, 2...\n"
+              "  list=<id> - Read the addresses in a stored watch list.\n"
+              "  list=<id> addr<N>=... - Store a watch list and read it.\n"
+              "  list=<id> clear - Delete a stored watch list.\n"
+              "Response is, for each address, a status byte (1 if readable) "
+              "followed by <size> bytes of data (zeroed if unreadable).",
+              response_len);
+      return XBOX_E_FAIL;
+    }
+
+    ret = SendPeekResponse(entries, num_entries, response, response_len, ctx);
+    DmFreePool(entries);
+    return ret;
+  }
+
+  if (list_id >= kMaxWatchLists) {
+    if (entries) {
+      DmFreePool(entries);
+    }
+    sprintf(response, "Invalid `list` param %d, must be < %d.", list_id,
+            kMaxWatchLists);
+    return XBOX_E_FAIL;
+  }
+
+  WatchList *list = watch_lists + list_id;
+  if (clear) {
+    if (entries) {
+      DmFreePool(entries);
+    }
+    FreeWatchList(list);
+    sprintf(response, "Cleared watch list %d.", list_id);
+    return XBOX_S_OK;
+  }
+
+  if (num_entries) {
+    FreeWatchList(list);
+    list->entries = entries;
+    list->num_entries = num_entries;
+  } else if (!list->num_entries) {
+    sprintf(response, "Watch list %d is empty.", list_id);
+    return XBOX_E_FAIL;
+  }
+
+  return SendPeekResponse(list->entries, list->num_entries, response,
+                          response_len, ctx);
+}
+
+HRESULT HandlePoke(const char *command, char *response, DWORD response_len,
+                   CommandContext *ctx) {
+  CommandParameters cp;
+  int32_t result = CPParseCommandParameters(command, &cp);
+  if (result < 0) {
+    return CPPrintError(result, response, response_len);
+  }
+
+  BatchEntry *entries = NULL;
+  uint32_t num_entries = 0;
+  HRESULT ret = ParseBatchEntries(&cp, TRUE, &entries, &num_entries, response,
+                                  response_len);
+  CPDelete(&cp);
+  if (ret != XBOX_S_OK) {
+    return ret;
+  }
+
+  if (!num_entries) {
+    *response = 0;
+    strncat(response,
+            "Missing required parameters.\n"
+            "  addr<N>=<address> val<N>=<value> [size<N>=<1,2,4>] - Write the "
+            "given values, N = 0, 1, 2...\n"
+            "Response is `written=<count> skipped=<count>`, followed by "
+            "`skipped_indices=<N>,...` if any address was not writable.",
+            response_len);
+    return XBOX_E_FAIL;
+  }
+
+  // Validate and apply every write without allowing the running title to be
+  // scheduled, so that readers never observe a partially applied batch.
+  uint32_t num_written = 0;
+  KIRQL old_irql = KeRaiseIrqlToDpcLevel();
+  BatchEntry *entry = entries;
+  for (uint32_t i = 0; i < num_entries; ++i, ++entry) {
+    if (!IsRangeAccessible(entry->address, entry->size, TRUE)) {
+      entry->size = 0;
+    }
+  }
+
+  entry = entries;
+  for (uint32_t i = 0; i < num_entries; ++i, ++entry) {
+    switch (entry->size) {
+      case 1:
+        *(uint8_t *)entry->address = (uint8_t)entry->value;
+        break;
+      case 2:
+        *(uint16_t *)entry->address = (uint16_t)entry->value;
+        break;
+      case 4:
+        *(uint32_t *)entry->address = entry->value;
+        break;
+      default:
+        continue;
+    }
+    ++num_written;
+  }
+  KfLowerIrql(old_irql);
+
+  // Report the index of each skipped entry so the caller can tell which
+  // addresses failed validation.
+  char *buffer = response;
+  buffer += sprintf(buffer, "written=%d skipped=%d", num_written,
+                    num_entries - num_written);
+  if (num_written != num_entries) {
+    char separator = '=';
+    buffer += sprintf(buffer, " skipped_indices");
+    entry = entries;
+    for (uint32_t i = 0; i < num_entries; ++i, ++entry) {
+      if (!entry->size) {
+        buffer += sprintf(buffer, "%c%d", separator, i);
+        separator = ',';
+      }
+    }
+  }
+
+  DmFreePool(entries);
+  return XBOX_S_OK;
+}
+
+static HRESULT ParseBatchEntries(CommandParameters *cp, BOOL with_values,
+                                 BatchEntry **entries, uint32_t *num_entries,
+                                 char *response, DWORD response_len) {
+  *entries = NULL;
+  *num_entries = 0;
+
+  char key[16];
+  uint32_t address;
+  sprintf(key, "addr%d", kMaxBatchEntries);
+  if (CPGetUInt32(key, &address, cp)) {
+    sprintf(response, "Too many addresses, a batch may contain at most %d.",
+            kMaxBatchEntries);
+    return XBOX_E_FAIL;
+  }
+
+  uint32_t count = 0;
+  for (; count < kMaxBatchEntries; ++count) {
+    sprintf(key, "addr%d", count);
+    if (!CPGetUInt32(key, &address, cp)) {
+      break;
+    }
+  }
+  if (!count) {
+    return XBOX_S_OK;
+  }
+
+  BatchEntry *ret =
+      (BatchEntry *)DmAllocatePoolWithTag(sizeof(*ret) * count, kTag);
+  if (!ret) {
+    sprintf(response, "Out of memory");
+    return XBOX_E_ACCESS_DENIED;
+  }
+
+  BatchEntry *entry = ret;
+  for (uint32_t i = 0; i < count; ++i, ++entry) {
+    sprintf(key, "addr%d", i);
+    CPGetUInt32(key, &address, cp);
+    entry->address = (intptr_t)address;
+
+    sprintf(key, "size%d", i);
+    if (!CPGetUInt32(key, &entry->size, cp)) {
+      entry->size = 4;
+    }
+
+    if (with_values) {
+      if (!(entry->size == 1 || entry->size == 2 || entry->size == 4)) {
+        DmFreePool(ret);
+        sprintf(response, "Invalid `size%d` param %d, must be 1, 2, or 4.", i,
+                entry->size);
+        return XBOX_E_FAIL;
+      }
+
+      sprintf(key, "val%d", i);
+      if (!CPGetUInt32(key, &entry->value, cp)) {
+        DmFreePool(ret);
+        sprintf(response, "Missing `val%d` param.", i);
+        return XBOX_E_FAIL;
+      }
+    } else {
+      if (!entry->size || entry->size > kMaxPeekSize) {
+        DmFreePool(ret);
+        sprintf(response, "Invalid `size%d` param %d, must be 1 - %d.", i,
+                entry->size, kMaxPeekSize);
+        return XBOX_E_FAIL;
+      }
+      entry->value = 0;
+    }
+  }
+
+  *entries = ret;
+  *num_entries = count;
+  return XBOX_S_OK;
+}
+
+static HRESULT SendPeekResponse(const BatchEntry *entries, uint32_t num_entries,
+                                char *response, DWORD response_len,
+                                CommandContext *ctx) {
+  uint32_t data_size = 0;
+  const BatchEntry *entry = entries;
+  for (uint32_t i = 0; i < num_entries; ++i, ++entry) {
+    data_size += 1 + entry->size;
+  }
+
+  ctx->buffer_size = data_size;
+  ctx->buffer = DmAllocatePoolWithTag(ctx->buffer_size, kTag);
+  if (!ctx->buffer) {
+    sprintf(response, "Out of memory");
+    return XBOX_E_ACCESS_DENIED;
+  }
+
+  // Capture every value without allowing the running title to be scheduled, so
+  // the batch is a consistent snapshot.
+  uint8_t *buffer = (uint8_t *)ctx->buffer;
+  KIRQL old_irql = KeRaiseIrqlToDpcLevel();
+  entry = entries;
+  for (uint32_t i = 0; i < num_entries; ++i, ++entry) {
+    if (IsRangeAccessible(entry->address, entry->size, FALSE)) {
+      *buffer++ = 1;
+      memcpy(buffer, (const void *)entry->address, entry->size);
+    } else {
+      *buffer++ = 0;
+      memset(buffer, 0, entry->size);
+    }
+    buffer += entry->size;
+  }
+  KfLowerIrql(old_irql);
+
+  ctx->user_data = 0;
+  ctx->handler = SendPeekData;
+  return XBOX_S_BINARY;
+}
+
+static HRESULT_API SendPeekData(CommandContext *ctx, char *response,
+                                DWORD response_len) {
+  uint32_t sent = (uint32_t)ctx->user_data++;
+  if (sent) {
+    DmFreePool(ctx->buffer);
+    return XBOX_S_NO_MORE_DATA;
+  }
+
+  ctx->data_size = ctx->buffer_size;
+  return XBOX_S_OK;
+}
+
+// Checks that every page in the given range is mapped (and writable if
+// requested), so that a bad address can be skipped instead of faulting.
+static BOOL IsRangeAccessible(intptr_t address, uint32_t size, BOOL writable) {
+  uint32_t start = (uint32_t)address;
+  uint32_t last = start + size - 1;
+  if (last < start) {
+    return FALSE;
+  }
+
+  uint32_t page = start & ~(kPageSize - 1);
+  uint32_t last_page = last & ~(kPageSize - 1);
+  for (; page <= last_page; page += kPageSize) {
+    if (!MmIsAddressValid((PVOID)page)) {
+      return FALSE;
+    }
+
+    if (writable) {
+      ULONG protect = MmQueryAddressProtect((PVOID)page);
+      if (!(protect & (PAGE_READWRITE | PAGE_EXECUTE_READWRITE))) {
+        return FALSE;
+      }
+    }
+
+    if (page == last_page) {
+      break;
+    }
+  }
+
+  return TRUE;
+}
+
+static void FreeWatchList(WatchList *list) {
+  if (list->entries) {
+    DmFreePool(list->entries);
+  }
+  list->entries = NULL;
+  list->num_entries = 0;
+}
@@ -0,0 +1,15 @@
+#ifndef TRAINER_DYNDXT_SRC_CMD_MEMORY_H_
+#define TRAINER_DYNDXT_SRC_CMD_MEMORY_H_
+
+#include "xbdm.h"
+
+// Reads a batch of addresses and returns their contents as a single binary
+// response.
+HRESULT HandlePeek(const char *command, char *response, DWORD response_len,
+                   CommandContext *ctx);
+
+// Writes a batch of values to memory in a single operation.
+HRESULT HandlePoke(const char *command, char *response, DWORD response_len,
+                   CommandContext *ctx);
+
+#endif  // TRAINER_DYNDXT_SRC_CMD_MEMORY_H_
@@ -7,11 +7,35 @@
 
 #include "command_processor_util.h"
 #include "memsearch.h"
+#include "spill_file.h"
 #include "vad_tree_util.h"
 
 static const uint32_t kTag = 0x74726E72;  // 'trnr'
 
 #define kMaxResultsPerBucket 512
+// Number of addresses buffered in memory between reads/writes of a spill file.
+#define kSpillBufferResults 4096
+// Number of hits collected during a scan before they are merged into the
+// region's results.
+#define kScanHitBufferSize 128
+// Regions are scanned in chunks of this many bytes. Before each chunk is
+// searched, the same number of bytes is prefetched a fixed distance ahead.
+#define kScanChunkSize 256
+#define kCacheLineSize 32
+
+// Distance in bytes between the chunk being searched and the memory being
+// prefetched, 0 to disable prefetching. Set by the build so that it can be
+// tuned against recorded session timings.
+#ifndef TRAINER_SCAN_PREFETCH_DISTANCE
+#define TRAINER_SCAN_PREFETCH_DISTANCE 2048
+#endif
+
+// Scratch files used to hold results that do not fit in the debug pool.
+// Filtering reads from one file and writes to the other.
+static const char *const kSpillPaths[2] = {
+    "\\Device\\Harddisk0\\Partition1\\trainer_results0.bin",
+    "\\Device\\Harddisk0\\Partition1\\trainer_results1.bin",
+};
 
 // Node in a linked list of results.
 // Each node holds multiple addresses to amortize the overhead of the links.
@@ -35,16 +59,37 @@ typedef struct SearchState {
 
   uint32_t num_regions;
   SearchRegion regions[128];
+
+  // Set when results are stored in `spill_files[spill_index]` rather than in
+  // the region buckets.
+  BOOL spilled;
+  uint32_t spill_index;
+  SpillFile spill_files[2];
+  // Staging buffer for spill file reads and writes.
+  intptr_t *spill_buffer;
+  uint32_t spill_buffer_used;
 } SearchState;
 
 typedef struct SearchResultsContext {
   // Index of the region whose contents are being returned.
   uint32_t current_region;
   const ResultBucket *current_bucket;
+  // Set once a spill file read has failed and the error has been reported.
+  BOOL read_failed;
 } SearchResultsContext;
 
 typedef BOOL (*Comparator)(uint32_t, uint32_t);
-typedef uint32_t (*FilterFunc)(ResultBucket *bucket, Comparator comparator);
+typedef uint32_t (*FilterFunc)(intptr_t *results, uint32_t num_results,
+                               Comparator comparator);
+typedef NTSTATUS (*MergeHitsFunc)(void *context, const intptr_t *hits,
+                                  uint32_t num_hits);
+
+// Context for MergeHitsToBuckets.
+typedef struct BucketMergeContext {
+  SearchRegion *region;
+  // The last bucket in the region's results, NULL if there are none yet.
+  ResultBucket *tail;
+} BucketMergeContext;
 
 SearchState search_state = {0};
 static const uint32_t kMaxRegions =
@@ -53,7 +98,7 @@ static const uint32_t kMaxRegions =
 static union { SearchResultsContext results_context; } context_store;
 
 static HRESULT StartNewSearch(uint32_t search_term, uint32_t byte_size,
-                              char *response, DWORD response_len,
+                              BOOL spill, char *response, DWORD response_len,
                               CommandContext *ctx);
 static HRESULT FilterToValue(uint32_t new_term, char *response,
                              DWORD response_len, CommandContext *ctx);
@@ -65,6 +110,8 @@ static HRESULT_API SendSearchResults(CommandContext *ctx, char *response,
                                      DWORD response_len);
 
 static void FreeSearchResults(ResultBucket *head);
+static void FreeRegionResults(void);
+static void FreeSpillState(void);
 static void FreeSearchState(void);
 
 static BOOL CmpGT(uint32_t a, uint32_t b) { return a > b; }
@@ -106,6 +153,7 @@ HRESULT HandleSearch(const char *command, char *response, DWORD response_len,
   bool new_value_found = CPGetUInt32("new", &new_term, &cp);
 
   bool fetch = CPHasKey("fetch", &cp);
+  bool spill = CPHasKey("spill", &cp);
   CPDelete(&cp);
 
   if (term_found) {
@@ -118,7 +166,8 @@ HRESULT HandleSearch(const char *command, char *response, DWORD response_len,
         return XBOX_E_FAIL;
       }
     }
-    return StartNewSearch(search_term, byte_size, response, response_len, ctx);
+    return StartNewSearch(search_term, byte_size, spill, response,
+                          response_len, ctx);
   }
 
   if (fetch) {
@@ -136,56 +185,204 @@ HRESULT HandleSearch(const char *command, char *response, DWORD response_len,
   *response = 0;
   strncat(response,
           "Missing required operation.\n"
-          "  term=<value> [byte_size=<1,2,4>] - Start a new search.\n"
+          "  term=<value> [byte_size=<1,2,4>] [spill] - Start a new search.\n"
+          "    spill - Store results on the HDD instead of in memory.\n"
           "  new=<value> - Filter results to the given value.\n"
           "  gte|gt|lt|lte|eq|ne - Filter using the given operation.\n"
-          "  fetch - Return the current list of results\n",
+          "  fetch - Return the current list of results. If spilled results\n"
+          "    cannot be read, the list ends with an `error=<status>` line.\n",
           response_len);
   strcat(response, command);
   return XBOX_E_FAIL;
 }
 
-static BOOL PopulateRegion(SearchRegion *region, uint32_t *result_count) {
-  *result_count = 0;
-  ResultBucket *results = NULL;
-  ResultBucket *last_bucket = NULL;
+static NTSTATUS SpillFlush(void) {
+  if (!search_state.spill_buffer_used) {
+    return STATUS_SUCCESS;
+  }
 
-  const uint8_t *start = (const uint8_t *)region->base;
-  const uint8_t *end = (const uint8_t *)region->end;
-  while (start) {
-    start = memsearch(start, end - start, &search_state.term,
-                      search_state.byte_size);
-    if (!start) {
-      return TRUE;
-    }
+  uint32_t size = search_state.spill_buffer_used * sizeof(intptr_t);
+  search_state.spill_buffer_used = 0;
+  return SpillFileWrite(&search_state.spill_files[search_state.spill_index],
+                        search_state.spill_buffer, size);
+}
+
+// Appends a batch of hits to the result buckets of a BucketMergeContext.
+static NTSTATUS MergeHitsToBuckets(void *context, const intptr_t *hits,
+                                   uint32_t num_hits) {
+  BucketMergeContext *merge_context = (BucketMergeContext *)context;
+  while (num_hits) {
+    ResultBucket *bucket = merge_context->tail;
 
     // Allocate a new bucket if necessary.
-    if (!results) {
-      results = (ResultBucket *)DmAllocatePoolWithTag(sizeof(*results), kTag);
-      if (!results) {
-        return FALSE;
+    if (!bucket || bucket->num_results == kMaxResultsPerBucket) {
+      ResultBucket *new_bucket =
+          (ResultBucket *)DmAllocatePoolWithTag(sizeof(*new_bucket), kTag);
+      if (!new_bucket) {
+        return STATUS_NO_MEMORY;
       }
+      new_bucket->next = NULL;
+      new_bucket->num_results = 0;
 
-      memset(results, 0, sizeof(*results));
-
-      if (last_bucket) {
-        last_bucket->next = results;
+      if (bucket) {
+        bucket->next = new_bucket;
       } else {
-        region->results = results;
+        merge_context->region->results = new_bucket;
       }
+      bucket = new_bucket;
+      merge_context->tail = bucket;
+    }
+
+    uint32_t count = kMaxResultsPerBucket - bucket->num_results;
+    if (count > num_hits) {
+      count = num_hits;
     }
+    memcpy(bucket->results + bucket->num_results, hits, count * sizeof(*hits));
+    bucket->num_results += count;
+    hits += count;
+    num_hits -= count;
+  }
 
-    ++(*result_count);
-    results->results[results->num_results++] = (intptr_t)start;
-    if (results->num_results == kMaxResultsPerBucket) {
-      last_bucket = results;
-      results = NULL;
+  return STATUS_SUCCESS;
+}
+
+// Appends a batch of hits to the current spill file of a SearchState.
+static NTSTATUS MergeHitsToSpillFile(void *context, const intptr_t *hits,
+                                     uint32_t num_hits) {
+  SearchState *state = (SearchState *)context;
+  while (num_hits) {
+    uint32_t count = kSpillBufferResults - state->spill_buffer_used;
+    if (count > num_hits) {
+      count = num_hits;
+    }
+    memcpy(state->spill_buffer + state->spill_buffer_used, hits,
+           count * sizeof(*hits));
+    state->spill_buffer_used += count;
+    hits += count;
+    num_hits -= count;
+
+    if (state->spill_buffer_used == kSpillBufferResults) {
+      NTSTATUS status = SpillFlush();
+      if (!NT_SUCCESS(status)) {
+        return status;
+      }
     }
+  }
+
+  return STATUS_SUCCESS;
+}
 
-    start += search_state.byte_size;
+// Hints the CPU to begin loading the given range into cache.
+static void PrefetchRange(const uint8_t *start, const uint8_t *end) {
+  for (; start < end; start += kCacheLineSize) {
+    __builtin_prefetch(start);
   }
+}
 
-  return TRUE;
+// Searches the given region for the search term.
+//
+// The region is processed in chunks of kScanChunkSize bytes, prefetching
+// TRAINER_SCAN_PREFETCH_DISTANCE bytes ahead of each one so that every line is
+// requested once, shortly before memsearch reaches it, without evicting the
+// data being searched. Hits are collected in a local buffer that is handed to
+// `merge` along with `merge_context` in batches so the scan loop does not touch
+// the result storage for every match.
+static NTSTATUS ScanRegion(const SearchRegion *region, MergeHitsFunc merge,
+                           void *merge_context, uint32_t *result_count) {
+  *result_count = 0;
+
+  intptr_t hits[kScanHitBufferSize];
+  uint32_t num_hits = 0;
+  NTSTATUS status;
+
+  const uint8_t *chunk = (const uint8_t *)region->base;
+  const uint8_t *end = (const uint8_t *)region->end;
+  const uint8_t *next = chunk;
+  while (chunk < end) {
+    const uint8_t *chunk_end =
+        (end - chunk > kScanChunkSize) ? chunk + kScanChunkSize : end;
+
+    if (TRAINER_SCAN_PREFETCH_DISTANCE &&
+        end - chunk > TRAINER_SCAN_PREFETCH_DISTANCE) {
+      const uint8_t *prefetch = chunk + TRAINER_SCAN_PREFETCH_DISTANCE;
+      PrefetchRange(prefetch, (end - prefetch > kScanChunkSize)
+                                  ? prefetch + kScanChunkSize
+                                  : end);
+    }
+
+    // Matches may straddle the end of the chunk, so the search extends into
+    // the next chunk, but only matches starting within this one are taken.
+    const uint8_t *search_end = (end - chunk_end > search_state.byte_size - 1)
+                                    ? chunk_end + search_state.byte_size - 1
+                                    : end;
+    while (next < chunk_end) {
+      const uint8_t *hit = memsearch(next, search_end - next,
+                                     &search_state.term,
+                                     search_state.byte_size);
+      if (!hit) {
+        next = chunk_end;
+        break;
+      }
+
+      hits[num_hits++] = (intptr_t)hit;
+      if (num_hits == kScanHitBufferSize) {
+        status = merge(merge_context, hits, num_hits);
+        if (!NT_SUCCESS(status)) {
+          return status;
+        }
+        *result_count += num_hits;
+        num_hits = 0;
+      }
+
+      next = hit + search_state.byte_size;
+    }
+
+    chunk = chunk_end;
+  }
+
+  if (!num_hits) {
+    return STATUS_SUCCESS;
+  }
+
+  status = merge(merge_context, hits, num_hits);
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  *result_count += num_hits;
+  return STATUS_SUCCESS;
+}
+
+// Performs the initial search, streaming results to a spill file.
+static NTSTATUS InitialSearchSpilled(uint32_t *result_count) {
+  *result_count = 0;
+
+  search_state.spill_buffer = (intptr_t *)DmAllocatePoolWithTag(
+      kSpillBufferResults * sizeof(intptr_t), kTag);
+  if (!search_state.spill_buffer) {
+    return STATUS_NO_MEMORY;
+  }
+  search_state.spill_buffer_used = 0;
+  search_state.spill_index = 0;
+  search_state.spilled = TRUE;
+
+  NTSTATUS status =
+      SpillFileOpen(&search_state.spill_files[0], kSpillPaths[0], true);
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+
+  SearchRegion *region = search_state.regions;
+  for (uint32_t i = 0; i < search_state.num_regions; ++i, ++region) {
+    uint32_t region_results = 0;
+    status = ScanRegion(region, MergeHitsToSpillFile, &search_state,
+                        &region_results);
+    if (!NT_SUCCESS(status)) {
+      return status;
+    }
+    *result_count += region_results;
+  }
+
+  return SpillFlush();
 }
 
 static BOOL InitialSearch(uint32_t *result_count) {
@@ -195,8 +392,10 @@ static BOOL InitialSearch(uint32_t *result_count) {
   for (uint32_t i = 0; i < search_state.num_regions; ++i, ++region) {
     FreeSearchResults(region->results);
     region->results = NULL;
+    BucketMergeContext merge_context = {region, NULL};
     uint32_t region_results = 0;
-    if (!PopulateRegion(region, &region_results)) {
+    if (!NT_SUCCESS(ScanRegion(region, MergeHitsToBuckets, &merge_context,
+                               &region_results))) {
       return FALSE;
     }
     *result_count += region_results;
@@ -211,47 +410,99 @@ static HRESULT FilterToValue(uint32_t new_term, char *response,
   return FilterOp(CmpEq, response, response_len, ctx);
 }
 
-static uint32_t FilterBucket8(ResultBucket *bucket, Comparator comparator) {
+static uint32_t Filter8(intptr_t *results, uint32_t num_results,
+                        Comparator comparator) {
   uint32_t target = search_state.term & 0xFF;
   uint32_t next_valid = 0;
-  for (uint32_t i = 0; i < bucket->num_results; ++i) {
-    intptr_t addr = bucket->results[i];
+  for (uint32_t i = 0; i < num_results; ++i) {
+    intptr_t addr = results[i];
     uint8_t value = *(uint8_t *)addr;
     if (comparator((uint32_t)value, target)) {
-      bucket->results[next_valid++] = addr;
+      results[next_valid++] = addr;
     }
   }
-  bucket->num_results = next_valid;
   return next_valid;
 }
 
-static uint32_t FilterBucket16(ResultBucket *bucket, Comparator comparator) {
+static uint32_t Filter16(intptr_t *results, uint32_t num_results,
+                         Comparator comparator) {
   uint32_t target = search_state.term & 0xFFFF;
   uint32_t next_valid = 0;
-  for (uint32_t i = 0; i < bucket->num_results; ++i) {
-    intptr_t addr = bucket->results[i];
+  for (uint32_t i = 0; i < num_results; ++i) {
+    intptr_t addr = results[i];
     uint16_t value = *(uint16_t *)addr;
     if (comparator((uint32_t)value, target)) {
-      bucket->results[next_valid++] = addr;
+      results[next_valid++] = addr;
     }
   }
-  bucket->num_results = next_valid;
   return next_valid;
 }
 
-static uint32_t FilterBucket32(ResultBucket *bucket, Comparator comparator) {
+static uint32_t Filter32(intptr_t *results, uint32_t num_results,
+                         Comparator comparator) {
   uint32_t next_valid = 0;
-  for (uint32_t i = 0; i < bucket->num_results; ++i) {
-    intptr_t addr = bucket->results[i];
+  for (uint32_t i = 0; i < num_results; ++i) {
+    intptr_t addr = results[i];
     uint32_t value = *(uint32_t *)addr;
     if (comparator(value, search_state.term)) {
-      bucket->results[next_valid++] = addr;
+      results[next_valid++] = addr;
     }
   }
-  bucket->num_results = next_valid;
   return next_valid;
 }
 
+// Streams the current spill file through `filter_func`, writing the surviving
+// results to the alternate spill file.
+static NTSTATUS FilterSpilled(FilterFunc filter_func, Comparator comparator,
+                              uint32_t *result_count) {
+  *result_count = 0;
+
+  SpillFile *input = &search_state.spill_files[search_state.spill_index];
+  uint32_t output_index = search_state.spill_index ^ 1;
+  SpillFile *output = &search_state.spill_files[output_index];
+
+  NTSTATUS status = SpillFileRewind(input);
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+
+  status = SpillFileOpen(output, kSpillPaths[output_index], true);
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+
+  while (TRUE) {
+    uint32_t bytes_read;
+    status = SpillFileRead(input, search_state.spill_buffer,
+                           kSpillBufferResults * sizeof(intptr_t), &bytes_read);
+    if (!NT_SUCCESS(status)) {
+      SpillFileClose(output);
+      return status;
+    }
+    if (!bytes_read) {
+      break;
+    }
+
+    uint32_t num_results = filter_func(
+        search_state.spill_buffer, bytes_read / sizeof(intptr_t), comparator);
+    if (!num_results) {
+      continue;
+    }
+
+    status = SpillFileWrite(output, search_state.spill_buffer,
+                            num_results * sizeof(intptr_t));
+    if (!NT_SUCCESS(status)) {
+      SpillFileClose(output);
+      return status;
+    }
+    *result_count += num_results;
+  }
+
+  SpillFileClose(input);
+  search_state.spill_index = output_index;
+  return STATUS_SUCCESS;
+}
+
 static HRESULT FilterOp(Comparator comparator, char *response,
                         DWORD response_len, CommandContext *ctx) {
   SearchRegion *region = search_state.regions;
@@ -259,13 +510,13 @@ static HRESULT FilterOp(Comparator comparator, char *response,
   FilterFunc filter_func;
   switch (search_state.byte_size) {
     case 1:
-      filter_func = FilterBucket8;
+      filter_func = Filter8;
       break;
     case 2:
-      filter_func = FilterBucket16;
+      filter_func = Filter16;
       break;
     case 4:
-      filter_func = FilterBucket32;
+      filter_func = Filter32;
       break;
     default:
       sprintf(response, "Bad state, byte_size = %d", search_state.byte_size);
@@ -273,11 +524,22 @@ static HRESULT FilterOp(Comparator comparator, char *response,
   }
 
   uint32_t total_results = 0;
-  for (uint32_t i = 0; i < search_state.num_regions; ++i, ++region) {
-    ResultBucket *bucket = region->results;
-    while (bucket) {
-      total_results += filter_func(bucket, comparator);
-      bucket = bucket->next;
+  if (search_state.spilled) {
+    NTSTATUS status = FilterSpilled(filter_func, comparator, &total_results);
+    if (!NT_SUCCESS(status)) {
+      FreeSearchState();
+      sprintf(response, "Failed to filter spilled results. 0x%X", status);
+      return XBOX_E_FAIL;
+    }
+  } else {
+    for (uint32_t i = 0; i < search_state.num_regions; ++i, ++region) {
+      ResultBucket *bucket = region->results;
+      while (bucket) {
+        bucket->num_results =
+            filter_func(bucket->results, bucket->num_results, comparator);
+        total_results += bucket->num_results;
+        bucket = bucket->next;
+      }
     }
   }
 
@@ -286,7 +548,7 @@ static HRESULT FilterOp(Comparator comparator, char *response,
 }
 
 static HRESULT StartNewSearch(uint32_t search_term, uint32_t byte_size,
-                              char *response, DWORD response_len,
+                              BOOL spill, char *response, DWORD response_len,
                               CommandContext *ctx) {
   FreeSearchState();
 
@@ -317,14 +579,24 @@ static HRESULT StartNewSearch(uint32_t search_term, uint32_t byte_size,
   VADFreeRegionInfoSet(&region_info_set);
 
   uint32_t total_results;
-  if (!InitialSearch(&total_results)) {
-    FreeSearchState();
-    *response = 0;
-    strncat(response, "Out of memory while performing search.", response_len);
-    return XBOX_E_ACCESS_DENIED;
+  if (!spill && !InitialSearch(&total_results)) {
+    // Fall back to storing the results on disk.
+    FreeRegionResults();
+    spill = TRUE;
+  }
+
+  if (spill) {
+    status = InitialSearchSpilled(&total_results);
+    if (!NT_SUCCESS(status)) {
+      FreeSearchState();
+      sprintf(response, "Out of memory while performing search. 0x%X",
+              status);
+      return XBOX_E_ACCESS_DENIED;
+    }
   }
 
-  sprintf(response, "result_count=%d", total_results);
+  sprintf(response, "result_count=%d%s", total_results,
+          search_state.spilled ? " spilled" : "");
   return XBOX_S_OK;
 }
 
@@ -333,6 +605,15 @@ static HRESULT HandleSendSearchResults(char *response, DWORD response_len,
   SearchResultsContext *results_ctx = &context_store.results_context;
   memset(results_ctx, 0, sizeof(*results_ctx));
 
+  if (search_state.spilled) {
+    NTSTATUS status = SpillFileRewind(
+        &search_state.spill_files[search_state.spill_index]);
+    if (!NT_SUCCESS(status)) {
+      sprintf(response, "Failed to rewind spilled results. 0x%X", status);
+      return XBOX_E_FAIL;
+    }
+  }
+
   ctx->buffer_size = 12 * kMaxResultsPerBucket + 1;
   ctx->buffer = DmAllocatePoolWithTag(ctx->buffer_size, kTag);
   if (!ctx->buffer) {
@@ -378,8 +659,51 @@ static BOOL NextPopulatedBucket(SearchResultsContext *results_ctx) {
   return TRUE;
 }
 
+static HRESULT_API SendSpilledSearchResults(CommandContext *ctx,
+                                            char *response,
+                                            DWORD response_len) {
+  SearchResultsContext *results_ctx = &context_store.results_context;
+  if (results_ctx->read_failed) {
+    DmFreePool(ctx->buffer);
+    return XBOX_S_NO_MORE_DATA;
+  }
+
+  uint32_t bytes_read;
+  NTSTATUS status =
+      SpillFileRead(&search_state.spill_files[search_state.spill_index],
+                    search_state.spill_buffer,
+                    kMaxResultsPerBucket * sizeof(intptr_t), &bytes_read);
+  if (!NT_SUCCESS(status)) {
+    // Terminate the list with an error line so that the client does not
+    // mistake a partial result set for a complete one.
+    results_ctx->read_failed = TRUE;
+    sprintf((char *)ctx->buffer, "error=0x%X Failed to read spilled results.",
+            status);
+    return XBOX_S_OK;
+  }
+
+  if (!bytes_read) {
+    DmFreePool(ctx->buffer);
+    return XBOX_S_NO_MORE_DATA;
+  }
+
+  char *buffer = (char *)ctx->buffer;
+  uint32_t num_results = bytes_read / sizeof(intptr_t);
+  for (uint32_t i = 0; i < num_results; ++i) {
+    int len =
+        sprintf(buffer, "0x%08X\n", (uint32_t)search_state.spill_buffer[i]);
+    buffer += len;
+  }
+
+  return XBOX_S_OK;
+}
+
 static HRESULT_API SendSearchResults(CommandContext *ctx, char *response,
                                      DWORD response_len) {
+  if (search_state.spilled) {
+    return SendSpilledSearchResults(ctx, response, response_len);
+  }
+
   SearchResultsContext *results_ctx = &context_store.results_context;
   if (results_ctx->current_region >= search_state.num_regions ||
       !NextPopulatedBucket(results_ctx)) {
@@ -391,7 +715,7 @@ static HRESULT_API SendSearchResults(CommandContext *ctx, char *response,
 
   char *buffer = (char *)ctx->buffer;
   for (uint32_t i = 0; i < bucket->num_results; ++i) {
-    int len = sprintf(buffer, "0x%08X\n", bucket->results[i]);
+    int len = sprintf(buffer, "0x%08X\n", (uint32_t)bucket->results[i]);
     buffer += len;
   }
 
@@ -413,10 +737,27 @@ static void FreeSearchResults(ResultBucket *head) {
   }
 }
 
-static void FreeSearchState(void) {
+static void FreeRegionResults(void) {
   for (uint32_t i = 0; i < search_state.num_regions; ++i) {
     FreeSearchResults(search_state.regions[i].results);
     search_state.regions[i].results = NULL;
   }
+}
+
+static void FreeSpillState(void) {
+  SpillFileClose(&search_state.spill_files[0]);
+  SpillFileClose(&search_state.spill_files[1]);
+  if (search_state.spill_buffer) {
+    DmFreePool(search_state.spill_buffer);
+    search_state.spill_buffer = NULL;
+  }
+  search_state.spill_buffer_used = 0;
+  search_state.spill_index = 0;
+  search_state.spilled = FALSE;
+}
+
+static void FreeSearchState(void) {
+  FreeRegionResults();
+  FreeSpillState();
   search_state.num_regions = 0;
 }
@@ -3,8 +3,10 @@
 #include <windows.h>
 //#include <xboxkrnl/xboxkrnl.h>
 
+#include "cmd_memory.h"
 #include "cmd_search.h"
 #include "nxdk_dxt_dll_main.h"
+#include "recorder.h"
 #include "xbdm.h"
 
 static const char kHandlerName[] = "trainer";
@@ -26,12 +28,16 @@ static HRESULT_API SendHelloData(CommandContext *ctx, char *response,
 
 static const CommandTableEntry kCommandTable[] = {
     {"hello", HandleHello},
+    {"peek", HandlePeek},
+    {"poke", HandlePoke},
+    {"record", HandleRecord},
     {"search", HandleSearch},
 };
 static const uint32_t kCommandTableNumEntries =
     sizeof(kCommandTable) / sizeof(kCommandTable[0]);
 
 HRESULT DXTMain(void) {
+  RecorderInit();
   return DmRegisterCommandProcessor(kHandlerName, ProcessCommand);
 }
 
@@ -43,7 +49,12 @@ static HRESULT_API ProcessCommand(const char *command, char *response,
   for (uint32_t i = 0; i < kCommandTableNumEntries; ++i, ++entry) {
     uint32_t len = strlen(entry->command);
     if (!strncmp(subcommand, entry->command, len)) {
-      return entry->processor(subcommand + len, response, response_len, ctx);
+      ULONGLONG start = RecorderBeginCommand();
+      HRESULT ret =
+          entry->processor(subcommand + len, response, response_len, ctx);
+      RecorderEndCommand(start, entry->command, subcommand + len, ret,
+                         response, ctx);
+      return ret;
     }
   }
 
@@ -0,0 +1,50 @@
+#include "record_entry.h"
+
+#include <stdio.h>
+
+static char *AppendQuoted(char *buffer, const char *key, const char *value) {
+  buffer += sprintf(buffer, " %s=\"", key);
+  RecordSanitize(buffer, value);
+  while (*buffer) {
+    ++buffer;
+  }
+  *buffer++ = '"';
+  *buffer = 0;
+  return buffer;
+}
+
+int RecordFormatHeader(char *buffer, uint32_t frequency) {
+  return sprintf(buffer, "frequency=%u\n", frequency);
+}
+
+int RecordFormatEntry(char *buffer, const RecordEntry *entry) {
+  char *end = buffer;
+  end += sprintf(end,
+                 "cmd=%s hr=0x%08X ticks=%u lines=%u bytes=%u pool_pages=%u "
+                 "available_pages=%u",
+                 entry->command, entry->result, entry->ticks, entry->lines,
+                 entry->bytes, entry->pool_pages, entry->available_pages);
+  end = AppendQuoted(end, "args", entry->args);
+  end = AppendQuoted(end, "response", entry->response);
+  *end++ = '\n';
+  *end = 0;
+  return (int)(end - buffer);
+}
+
+uint32_t RecordCountLines(const char *text) {
+  uint32_t lines = *text ? 1 : 0;
+  for (; *text; ++text) {
+    if (*text == '\n' && text[1]) {
+      ++lines;
+    }
+  }
+  return lines;
+}
+
+void RecordSanitize(char *dest, const char *src) {
+  for (uint32_t i = 0; i < kRecordMaxQuotedLength && src[i]; ++i) {
+    char c = src[i];
+    *dest++ = (c == '"' || c < ' ') ? '_' : c;
+  }
+  *dest = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef TRAINER_DYNDXT_SRC_RECORD_ENTRY_H_
+#define TRAINER_DYNDXT_SRC_RECORD_ENTRY_H_
+
+#include <stdint.h>
+
+// Maximum length of a quoted argument or response within a log entry.
+#define kRecordMaxQuotedLength 160
+// Size of a buffer large enough to hold any formatted log line.
+#define kRecordMaxLineLength 512
+
+// Describes a single command in a session log.
+//
+// Session logs start with a `frequency=<ticks per second>` line, followed by
+// one line of space separated key=value pairs per command.
+typedef struct RecordEntry {
+  const char *command;
+  const char *args;
+  const char *response;
+  uint32_t result;
+  // Time spent processing the command, including any continuation calls.
+  uint32_t ticks;
+  // Number of lines sent by a multiline response.
+  uint32_t lines;
+  // Number of bytes sent by a binary response.
+  uint32_t bytes;
+  uint32_t pool_pages;
+  uint32_t available_pages;
+} RecordEntry;
+
+// Formats the header line of a session log into `buffer`, which must hold at
+// least kRecordMaxLineLength characters. Returns the length of the line.
+int RecordFormatHeader(char *buffer, uint32_t frequency);
+
+// Formats `entry` as a newline terminated log line into `buffer`, which must
+// hold at least kRecordMaxLineLength characters. Returns the length of the
+// line.
+int RecordFormatEntry(char *buffer, const RecordEntry *entry);
+
+// Returns the number of lines in the given multiline response chunk.
+uint32_t RecordCountLines(const char *text);
+
+// Copies at most kRecordMaxQuotedLength characters of `src` into `dest`,
+// replacing any characters that would break the line format. `dest` must hold
+// at least kRecordMaxQuotedLength + 1 characters.
+void RecordSanitize(char *dest, const char *src);
+
+#endif  // TRAINER_DYNDXT_SRC_RECORD_ENTRY_H_
@@ -0,0 +1,317 @@
+#include "recorder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "command_processor_util.h"
+#include "record_entry.h"
+#include "spill_file.h"
+#include "vad_tree_util.h"
+
+static const char kRecordPath[] =
+    "\\Device\\Harddisk0\\Partition1\\trainer_session.log";
+static const char kDumpPath[] =
+    "\\Device\\Harddisk0\\Partition1\\trainer_memory.bin";
+
+typedef HRESULT_API (*ContinuationHandler)(CommandContext *ctx, char *response,
+                                           DWORD response_len);
+
+// Maximum number of connections whose responses can be tracked at once.
+#define kMaxPendingCommands 8
+
+// Tracks a command whose response is still being sent.
+typedef struct PendingCommand {
+  // The connection sending the response, NULL if this slot is free.
+  CommandContext *ctx;
+  // The command's own continuation handler.
+  ContinuationHandler handler;
+  // Set if the entry should not be logged because recording was started or
+  // stopped while the response was in flight.
+  BOOL discard;
+  BOOL binary;
+  ULONGLONG elapsed;
+  RecordEntry entry;
+  char args[kRecordMaxQuotedLength + 1];
+  char response[kRecordMaxQuotedLength + 1];
+} PendingCommand;
+
+// Guards the state below, which is shared by the XBDM connection threads.
+static RTL_CRITICAL_SECTION record_lock;
+static SpillFile record_file = {NULL};
+static char record_line[kRecordMaxLineLength];
+static PendingCommand pending_commands[kMaxPendingCommands] = {0};
+
+static NTSTATUS StartRecording(void);
+static void StopRecording(void);
+static NTSTATUS WriteLine(const char *line);
+static NTSTATUS DumpWritableRegions(uint32_t *num_regions);
+static void WriteEntry(RecordEntry *entry, ULONGLONG elapsed);
+static PendingCommand *FindPending(const CommandContext *ctx);
+static void DiscardPending(void);
+static HRESULT_API RecordContinuation(CommandContext *ctx, char *response,
+                                      DWORD response_len);
+
+HRESULT HandleRecord(const char *command, char *response, DWORD response_len,
+                     CommandContext *ctx) {
+  CommandParameters cp;
+  int32_t result = CPParseCommandParameters(command, &cp);
+  if (result < 0) {
+    return CPPrintError(result, response, response_len);
+  }
+
+  bool start = CPHasKey("start", &cp);
+  bool stop = CPHasKey("stop", &cp);
+  bool dump = CPHasKey("dump", &cp);
+  CPDelete(&cp);
+
+  if (start) {
+    RtlEnterCriticalSection(&record_lock);
+    StopRecording();
+    NTSTATUS status = StartRecording();
+    RtlLeaveCriticalSection(&record_lock);
+    if (!NT_SUCCESS(status)) {
+      sprintf(response, "Failed to open session log. 0x%X", status);
+      return XBOX_E_FAIL;
+    }
+    *response = 0;
+    strncat(response, kRecordPath, response_len);
+    return XBOX_S_OK;
+  }
+
+  if (stop) {
+    RtlEnterCriticalSection(&record_lock);
+    StopRecording();
+    RtlLeaveCriticalSection(&record_lock);
+    *response = 0;
+    return XBOX_S_OK;
+  }
+
+  if (dump) {
+    uint32_t num_regions;
+    NTSTATUS status = DumpWritableRegions(&num_regions);
+    if (!NT_SUCCESS(status)) {
+      sprintf(response, "Failed to write memory image. 0x%X", status);
+      return XBOX_E_FAIL;
+    }
+    sprintf(response, "Wrote %d regions to %s", num_regions, kDumpPath);
+    return XBOX_S_OK;
+  }
+
+  *response = 0;
+  strncat(response,
+          "Missing required operation.\n"
+          "  start - Begin logging commands to the session log.\n"
+          "  stop - Stop logging commands.\n"
+          "  dump - Write the writable memory regions to an image that can\n"
+          "    be used to replay the session log.\n",
+          response_len);
+  return XBOX_E_FAIL;
+}
+
+void RecorderInit(void) { RtlInitializeCriticalSection(&record_lock); }
+
+ULONGLONG RecorderBeginCommand(void) {
+  if (!record_file.handle) {
+    return 0;
+  }
+  return KeQueryPerformanceCounter();
+}
+
+void RecorderEndCommand(ULONGLONG start, const char *command, const char *args,
+                        HRESULT result, const char *response,
+                        CommandContext *ctx) {
+  RtlEnterCriticalSection(&record_lock);
+
+  // A connection only has one response in flight, so a slot still held by
+  // this context belongs to a response that was abandoned (e.g., the client
+  // disconnected during a fetch).
+  PendingCommand *pending = FindPending(ctx);
+  if (pending) {
+    pending->ctx = NULL;
+  }
+
+  // Commands that started before recording was enabled (including the
+  // `record start` that enabled it) have no start time.
+  if (!record_file.handle || !start) {
+    RtlLeaveCriticalSection(&record_lock);
+    return;
+  }
+
+  ULONGLONG elapsed = KeQueryPerformanceCounter() - start;
+
+  RecordEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.command = command;
+  entry.args = args;
+  entry.response = response;
+  entry.result = result;
+
+  pending = NULL;
+  if ((result == XBOX_S_MULTILINE || result == XBOX_S_BINARY) &&
+      ctx->handler) {
+    pending = FindPending(NULL);
+  }
+  if (!pending) {
+    WriteEntry(&entry, elapsed);
+    RtlLeaveCriticalSection(&record_lock);
+    return;
+  }
+
+  // The command and response buffers are reused before the continuation
+  // completes, so keep copies for the log entry.
+  RecordSanitize(pending->args, args);
+  RecordSanitize(pending->response, response);
+  entry.args = pending->args;
+  entry.response = pending->response;
+
+  pending->ctx = ctx;
+  pending->entry = entry;
+  pending->discard = FALSE;
+  pending->binary = result == XBOX_S_BINARY;
+  pending->elapsed = elapsed;
+  pending->handler = (ContinuationHandler)ctx->handler;
+  ctx->handler = RecordContinuation;
+
+  RtlLeaveCriticalSection(&record_lock);
+}
+
+static HRESULT_API RecordContinuation(CommandContext *ctx, char *response,
+                                      DWORD response_len) {
+  // The slot cannot be released by another thread while this connection's
+  // response is in flight, so it remains valid outside of the lock.
+  RtlEnterCriticalSection(&record_lock);
+  PendingCommand *pending = FindPending(ctx);
+  RtlLeaveCriticalSection(&record_lock);
+  if (!pending) {
+    return XBOX_S_NO_MORE_DATA;
+  }
+
+  ULONGLONG start = KeQueryPerformanceCounter();
+  HRESULT result = pending->handler(ctx, response, response_len);
+  ULONGLONG elapsed = KeQueryPerformanceCounter() - start;
+
+  RtlEnterCriticalSection(&record_lock);
+  pending->elapsed += elapsed;
+  if (result == XBOX_S_OK) {
+    if (pending->binary) {
+      pending->entry.bytes += ctx->data_size;
+    } else {
+      pending->entry.lines += RecordCountLines((const char *)ctx->buffer);
+    }
+  } else {
+    // Any other result ends the response.
+    if (!pending->discard && record_file.handle) {
+      WriteEntry(&pending->entry, pending->elapsed);
+    }
+    pending->ctx = NULL;
+  }
+  RtlLeaveCriticalSection(&record_lock);
+
+  return result;
+}
+
+// Must be called with record_lock held.
+static void WriteEntry(RecordEntry *entry, ULONGLONG elapsed) {
+  entry->ticks = (elapsed >> 32) ? 0xFFFFFFFF : (uint32_t)elapsed;
+
+  MM_STATISTICS stats;
+  memset(&stats, 0, sizeof(stats));
+  stats.Length = sizeof(stats);
+  MmQueryStatistics(&stats);
+  entry->pool_pages = stats.PoolPagesCommitted;
+  entry->available_pages = stats.AvailablePages;
+
+  RecordFormatEntry(record_line, entry);
+  if (!NT_SUCCESS(WriteLine(record_line))) {
+    StopRecording();
+  }
+}
+
+// Returns the slot tracking `ctx`, or a free slot if `ctx` is NULL. Must be
+// called with record_lock held.
+static PendingCommand *FindPending(const CommandContext *ctx) {
+  PendingCommand *pending = pending_commands;
+  for (uint32_t i = 0; i < kMaxPendingCommands; ++i, ++pending) {
+    if (pending->ctx == ctx) {
+      return pending;
+    }
+  }
+  return NULL;
+}
+
+// Prevents responses that are in flight from being logged. Their slots stay
+// in use so that the wrapped handlers can still be forwarded to. Must be
+// called with record_lock held.
+static void DiscardPending(void) {
+  PendingCommand *pending = pending_commands;
+  for (uint32_t i = 0; i < kMaxPendingCommands; ++i, ++pending) {
+    if (pending->ctx) {
+      pending->discard = TRUE;
+    }
+  }
+}
+
+// Must be called with record_lock held.
+static NTSTATUS StartRecording(void) {
+  DiscardPending();
+
+  NTSTATUS status = SpillFileOpen(&record_file, kRecordPath, false);
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+
+  // Ticks are reported in units of the performance counter.
+  RecordFormatHeader(record_line, (uint32_t)KeQueryPerformanceFrequency());
+  status = WriteLine(record_line);
+  if (!NT_SUCCESS(status)) {
+    StopRecording();
+  }
+  return status;
+}
+
+// Must be called with record_lock held.
+static void StopRecording(void) {
+  DiscardPending();
+  SpillFileClose(&record_file);
+}
+
+static NTSTATUS WriteLine(const char *line) {
+  return SpillFileWrite(&record_file, line, strlen(line));
+}
+
+// Writes each writable region as a little endian uint32_t base address and
+// uint32_t size, followed by the contents of the region.
+static NTSTATUS DumpWritableRegions(uint32_t *num_regions) {
+  *num_regions = 0;
+
+  VADRegionInfoSet region_info_set;
+  NTSTATUS status = VADGetWritableRegions(&region_info_set);
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+
+  SpillFile dump_file = {NULL};
+  status = SpillFileOpen(&dump_file, kDumpPath, false);
+  if (!NT_SUCCESS(status)) {
+    VADFreeRegionInfoSet(&region_info_set);
+    return status;
+  }
+
+  MEMORY_BASIC_INFORMATION *info = region_info_set.entries;
+  for (uint32_t i = 0; i < region_info_set.num_entries; ++i, ++info) {
+    uint32_t header[2] = {(uint32_t)info->BaseAddress, info->RegionSize};
+    status = SpillFileWrite(&dump_file, header, sizeof(header));
+    if (!NT_SUCCESS(status)) {
+      break;
+    }
+    status = SpillFileWrite(&dump_file, info->BaseAddress, info->RegionSize);
+    if (!NT_SUCCESS(status)) {
+      break;
+    }
+    ++(*num_regions);
+  }
+
+  SpillFileClose(&dump_file);
+  VADFreeRegionInfoSet(&region_info_set);
+  return status;
+}
@@ -0,0 +1,32 @@
+#ifndef TRAINER_DYNDXT_SRC_RECORDER_H_
+#define TRAINER_DYNDXT_SRC_RECORDER_H_
+
+#include <xboxkrnl/xboxkrnl.h>
+
+#include "xbdm.h"
+
+// Starts or stops logging of every trainer command to a file on the HDD.
+HRESULT HandleRecord(const char *command, char *response, DWORD response_len,
+                     CommandContext *ctx);
+
+// Initializes the recorder. Must be called before any other Recorder function.
+void RecorderInit(void);
+
+// Returns a timestamp to be passed to RecorderEndCommand, or 0 if recording is
+// not active.
+ULONGLONG RecorderBeginCommand(void);
+
+// Appends an entry for a completed command to the session log, if recording
+// is active and `start` was captured while recording.
+//
+// If the command installed a continuation handler in `ctx` (multiline and
+// binary responses), the handler is wrapped and the entry is written once the
+// response is complete, so that it includes the time spent in the
+// continuation and the number of lines or bytes sent. Responses are tracked
+// per connection; if too many are in flight at once, the command is logged
+// without its continuation.
+void RecorderEndCommand(ULONGLONG start, const char *command, const char *args,
+                        HRESULT result, const char *response,
+                        CommandContext *ctx);
+
+#endif  // TRAINER_DYNDXT_SRC_RECORDER_H_
@@ -0,0 +1,70 @@
+#include "spill_file.h"
+
+#include <xboxkrnl/xboxkrnl.h>
+
+int32_t SpillFileOpen(SpillFile *file, const char *path, bool delete_on_close) {
+  ANSI_STRING object_name;
+  RtlInitAnsiString(&object_name, path);
+
+  OBJECT_ATTRIBUTES attributes;
+  attributes.RootDirectory = NULL;
+  attributes.ObjectName = &object_name;
+  attributes.Attributes = OBJ_CASE_INSENSITIVE;
+
+  ACCESS_MASK access = GENERIC_READ | GENERIC_WRITE | SYNCHRONIZE;
+  ULONG options = FILE_SYNCHRONOUS_IO_NONALERT | FILE_SEQUENTIAL_ONLY |
+                  FILE_NON_DIRECTORY_FILE;
+  if (delete_on_close) {
+    access |= DELETE;
+    options |= FILE_DELETE_ON_CLOSE;
+  }
+
+  IO_STATUS_BLOCK io_status;
+  HANDLE handle;
+  NTSTATUS status =
+      NtCreateFile(&handle, access, &attributes, &io_status, NULL,
+                   FILE_ATTRIBUTE_NORMAL, 0, FILE_OVERWRITE_IF, options);
+  file->handle = NT_SUCCESS(status) ? handle : NULL;
+  return status;
+}
+
+int32_t SpillFileWrite(SpillFile *file, const void *data, uint32_t size) {
+  IO_STATUS_BLOCK io_status;
+  NTSTATUS status = NtWriteFile(file->handle, NULL, NULL, NULL, &io_status,
+                                (PVOID)data, size, NULL);
+  if (NT_SUCCESS(status) && io_status.Information != size) {
+    return STATUS_DISK_FULL;
+  }
+  return status;
+}
+
+int32_t SpillFileRewind(SpillFile *file) {
+  IO_STATUS_BLOCK io_status;
+  FILE_POSITION_INFORMATION position;
+  position.CurrentByteOffset.QuadPart = 0;
+  return NtSetInformationFile(file->handle, &io_status, &position,
+                              sizeof(position), FilePositionInformation);
+}
+
+int32_t SpillFileRead(SpillFile *file, void *data, uint32_t size,
+                      uint32_t *bytes_read) {
+  IO_STATUS_BLOCK io_status;
+  NTSTATUS status = NtReadFile(file->handle, NULL, NULL, NULL, &io_status,
+                               data, size, NULL);
+  if (status == STATUS_END_OF_FILE) {
+    *bytes_read = 0;
+    return STATUS_SUCCESS;
+  }
+
+  *bytes_read = NT_SUCCESS(status) ? io_status.Information : 0;
+  return status;
+}
+
+void SpillFileClose(SpillFile *file) {
+  if (!file->handle) {
+    return;
+  }
+
+  NtClose(file->handle);
+  file->handle = NULL;
+}
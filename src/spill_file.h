@@ -0,0 +1,38 @@
+#ifndef TRAINER_DYNDXT_SRC_SPILL_FILE_H_
+#define TRAINER_DYNDXT_SRC_SPILL_FILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sequentially accessed file, used as scratch space for data that does not fit
+// in the debug pool and for logs.
+//
+// Spill files are only accessed sequentially: they are written from start to
+// end, rewound, and then read back in order.
+//
+// Functions return a non-negative value on success and a negative,
+// platform-specific error code (an NTSTATUS on the Xbox) on failure.
+typedef struct SpillFile {
+  // Platform-specific handle to the open file, NULL if not open.
+  void *handle;
+} SpillFile;
+
+// Creates (or truncates) the file at the given path. If `delete_on_close` is
+// set the file is removed when it is closed.
+int32_t SpillFileOpen(SpillFile *file, const char *path, bool delete_on_close);
+
+// Appends `size` bytes to the file.
+int32_t SpillFileWrite(SpillFile *file, const void *data, uint32_t size);
+
+// Moves the file position back to the start of the file.
+int32_t SpillFileRewind(SpillFile *file);
+
+// Reads up to `size` bytes from the current position. `bytes_read` is set to 0
+// once the end of the file is reached.
+int32_t SpillFileRead(SpillFile *file, void *data, uint32_t size,
+                      uint32_t *bytes_read);
+
+// Closes the file. Safe to call on a file that was never opened.
+void SpillFileClose(SpillFile *file);
+
+#endif  // TRAINER_DYNDXT_SRC_SPILL_FILE_H_
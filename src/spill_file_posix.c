@@ -0,0 +1,74 @@
+#include "spill_file.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Host implementation of SpillFile, used by the replay tool.
+//
+// Console paths (e.g., `\Device\Harddisk0\Partition1\name`) are mapped to
+// their final component within the system temporary directory.
+
+static void HostPath(char *host_path, size_t host_path_len, const char *path) {
+  const char *name = strrchr(path, '\\');
+  name = name ? name + 1 : path;
+  if (strchr(path, '\\')) {
+    snprintf(host_path, host_path_len, "%s/%s", P_tmpdir, name);
+  } else {
+    snprintf(host_path, host_path_len, "%s", path);
+  }
+}
+
+int32_t SpillFileOpen(SpillFile *file, const char *path, bool delete_on_close) {
+  char host_path[1024];
+  HostPath(host_path, sizeof(host_path), path);
+
+  FILE *handle = fopen(host_path, "w+b");
+  if (!handle) {
+    file->handle = NULL;
+    return -errno;
+  }
+
+  // An unlinked file remains usable until it is closed.
+  if (delete_on_close) {
+    unlink(host_path);
+  }
+
+  file->handle = handle;
+  return 0;
+}
+
+int32_t SpillFileWrite(SpillFile *file, const void *data, uint32_t size) {
+  if (fwrite(data, 1, size, (FILE *)file->handle) != size) {
+    return errno ? -errno : -ENOSPC;
+  }
+  return 0;
+}
+
+int32_t SpillFileRewind(SpillFile *file) {
+  if (fseek((FILE *)file->handle, 0, SEEK_SET)) {
+    return -errno;
+  }
+  return 0;
+}
+
+int32_t SpillFileRead(SpillFile *file, void *data, uint32_t size,
+                      uint32_t *bytes_read) {
+  FILE *handle = (FILE *)file->handle;
+  *bytes_read = fread(data, 1, size, handle);
+  if (ferror(handle)) {
+    *bytes_read = 0;
+    return -EIO;
+  }
+  return 0;
+}
+
+void SpillFileClose(SpillFile *file) {
+  if (!file->handle) {
+    return;
+  }
+
+  fclose((FILE *)file->handle);
+  file->handle = NULL;
+}
@@ -0,0 +1,170 @@
+#include "host_shims.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command_processor_util.h"
+#include "vad_tree_util.h"
+#include "xbdm.h"
+
+#define kMaxRegions 1024
+
+// Prefixes each pool allocation so that frees can be accounted for.
+typedef union PoolHeader {
+  size_t size;
+  max_align_t alignment;
+} PoolHeader;
+
+static size_t pool_limit = 0;
+static size_t pool_in_use = 0;
+
+static uint32_t num_regions = 0;
+static MEMORY_BASIC_INFORMATION regions[kMaxRegions];
+
+void HostPoolSetLimit(size_t limit) { pool_limit = limit; }
+
+size_t HostPoolBytesInUse(void) { return pool_in_use; }
+
+size_t HostPoolBytesAvailable(void) {
+  if (!pool_limit || pool_in_use >= pool_limit) {
+    return 0;
+  }
+  return pool_limit - pool_in_use;
+}
+
+bool HostAddWritableRegion(void *base, size_t size) {
+  if (num_regions == kMaxRegions) {
+    return false;
+  }
+
+  MEMORY_BASIC_INFORMATION *info = regions + num_regions++;
+  memset(info, 0, sizeof(*info));
+  info->BaseAddress = base;
+  info->AllocationBase = base;
+  info->RegionSize = size;
+  return true;
+}
+
+void *DmAllocatePoolWithTag(DWORD size, DWORD tag) {
+  if (pool_limit && pool_in_use + size > pool_limit) {
+    return NULL;
+  }
+
+  PoolHeader *header = (PoolHeader *)malloc(sizeof(*header) + size);
+  if (!header) {
+    return NULL;
+  }
+  header->size = size;
+  pool_in_use += size;
+  return header + 1;
+}
+
+void DmFreePool(void *pool) {
+  PoolHeader *header = (PoolHeader *)pool - 1;
+  pool_in_use -= header->size;
+  free(header);
+}
+
+void DbgPrint(const char *format, ...) {}
+
+NTSTATUS VADGetWritableRegions(VADRegionInfoSet *ret) {
+  ret->num_entries = num_regions;
+  ret->entries =
+      DmAllocatePoolWithTag(sizeof(ret->entries[0]) * num_regions, 0);
+  if (!ret->entries) {
+    return STATUS_NO_MEMORY;
+  }
+
+  memcpy(ret->entries, regions, sizeof(ret->entries[0]) * num_regions);
+  return STATUS_SUCCESS;
+}
+
+void VADFreeRegionInfoSet(VADRegionInfoSet *tofree) {
+  if (!tofree->entries) {
+    return;
+  }
+
+  DmFreePool(tofree->entries);
+  tofree->entries = NULL;
+  tofree->num_entries = 0;
+}
+
+int32_t CPParseCommandParameters(const char *params,
+                                 CommandParameters *result) {
+  memset(result, 0, sizeof(*result));
+
+  result->buffer = strdup(params);
+  if (!result->buffer) {
+    return -1;
+  }
+
+  size_t max_entries = strlen(params) / 2 + 1;
+  result->keys = (char **)calloc(max_entries, sizeof(char *));
+  result->values = (char **)calloc(max_entries, sizeof(char *));
+  if (!result->keys || !result->values) {
+    CPDelete(result);
+    return -1;
+  }
+
+  char *save_ptr = NULL;
+  for (char *token = strtok_r(result->buffer, " ", &save_ptr); token;
+       token = strtok_r(NULL, " ", &save_ptr)) {
+    char *value = strchr(token, '=');
+    if (value) {
+      *value++ = 0;
+    }
+    result->keys[result->entries] = token;
+    result->values[result->entries] = value;
+    ++result->entries;
+  }
+
+  return result->entries;
+}
+
+void CPDelete(CommandParameters *params) {
+  free(params->buffer);
+  free(params->keys);
+  free(params->values);
+  memset(params, 0, sizeof(*params));
+}
+
+static const char *FindValue(const char *key, CommandParameters *params,
+                             bool *found) {
+  for (int32_t i = 0; i < params->entries; ++i) {
+    if (!strcmp(params->keys[i], key)) {
+      *found = true;
+      return params->values[i];
+    }
+  }
+  *found = false;
+  return NULL;
+}
+
+bool CPHasKey(const char *key, CommandParameters *params) {
+  bool found;
+  FindValue(key, params, &found);
+  return found;
+}
+
+bool CPGetUInt32(const char *key, uint32_t *result, CommandParameters *params) {
+  bool found;
+  const char *value = FindValue(key, params, &found);
+  if (!value || !*value) {
+    return false;
+  }
+
+  char *end;
+  unsigned long parsed = strtoul(value, &end, 0);
+  if (*end) {
+    return false;
+  }
+  *result = (uint32_t)parsed;
+  return true;
+}
+
+HRESULT CPPrintError(int32_t error, char *response, DWORD response_len) {
+  snprintf(response, response_len, "Failed to parse parameters. %d", error);
+  return XBOX_E_FAIL;
+}
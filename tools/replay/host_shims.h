@@ -0,0 +1,21 @@
+#ifndef TRAINER_DYNDXT_TOOLS_REPLAY_HOST_SHIMS_H_
+#define TRAINER_DYNDXT_TOOLS_REPLAY_HOST_SHIMS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Limits the number of bytes that may be allocated from the emulated debug
+// pool. 0 removes the limit.
+void HostPoolSetLimit(size_t limit);
+
+// Returns the number of bytes currently allocated from the emulated pool.
+size_t HostPoolBytesInUse(void);
+
+// Returns the number of bytes that may still be allocated, or 0 if the pool is
+// unlimited.
+size_t HostPoolBytesAvailable(void);
+
+// Registers a region of host memory to be reported as writable.
+bool HostAddWritableRegion(void *base, size_t size);
+
+#endif  // TRAINER_DYNDXT_TOOLS_REPLAY_HOST_SHIMS_H_
@@ -0,0 +1,25 @@
+#ifndef TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_COMMAND_PROCESSOR_UTIL_H_
+#define TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_COMMAND_PROCESSOR_UTIL_H_
+
+// Host stand-in for the nxdk_dyndxt command parameter parser.
+
+#include "xbdm.h"
+
+typedef struct CommandParameters {
+  int32_t entries;
+  char *buffer;
+  char **keys;
+  char **values;
+} CommandParameters;
+
+// Parses space separated `key` and `key=value` parameters. Returns the number
+// of parameters or a negative value on failure.
+int32_t CPParseCommandParameters(const char *params, CommandParameters *result);
+void CPDelete(CommandParameters *params);
+
+bool CPHasKey(const char *key, CommandParameters *params);
+bool CPGetUInt32(const char *key, uint32_t *result, CommandParameters *params);
+
+HRESULT CPPrintError(int32_t error, char *response, DWORD response_len);
+
+#endif  // TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_COMMAND_PROCESSOR_UTIL_H_
@@ -0,0 +1,6 @@
+#ifndef TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_LIB_XBOXKRNL_XBOXKRNL_H_
+#define TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_LIB_XBOXKRNL_XBOXKRNL_H_
+
+#include <xboxkrnl/xboxkrnl.h>
+
+#endif  // TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_LIB_XBOXKRNL_XBOXKRNL_H_
@@ -0,0 +1,6 @@
+#ifndef TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_WINDOWS_H_
+#define TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_WINDOWS_H_
+
+#include <xboxkrnl/xboxkrnl.h>
+
+#endif  // TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_WINDOWS_H_
@@ -0,0 +1,33 @@
+#ifndef TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_XBDM_H_
+#define TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_XBDM_H_
+
+// Host stand-in for the subset of the XBDM interface used by the search code.
+//
+// The replay tool only relies on the result codes being distinct.
+
+#include <xboxkrnl/xboxkrnl.h>
+
+#define HRESULT_API HRESULT
+
+#define XBOX_S_OK ((HRESULT)0x02DA0000)
+#define XBOX_S_MULTILINE ((HRESULT)0x02DA0002)
+#define XBOX_S_BINARY ((HRESULT)0x02DA0003)
+#define XBOX_S_NO_MORE_DATA ((HRESULT)0x02DA0010)
+#define XBOX_E_FAIL ((HRESULT)0x82DA0000)
+#define XBOX_E_ACCESS_DENIED ((HRESULT)0x82DA0017)
+#define XBOX_E_UNKNOWN_COMMAND ((HRESULT)0x82DA0007)
+
+typedef struct CommandContext {
+  HRESULT_API (*handler)(struct CommandContext *ctx, char *response,
+                         DWORD response_len);
+  DWORD data_size;
+  void *buffer;
+  DWORD buffer_size;
+  void *user_data;
+  DWORD bytes_remaining;
+} CommandContext;
+
+void *DmAllocatePoolWithTag(DWORD size, DWORD tag);
+void DmFreePool(void *pool);
+
+#endif  // TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_XBDM_H_
@@ -0,0 +1,43 @@
+#ifndef TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_XBOXKRNL_XBOXKRNL_H_
+#define TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_XBOXKRNL_XBOXKRNL_H_
+
+// Host stand-in for the subset of the nxdk kernel header used by the search
+// code.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BOOL;
+typedef uint32_t DWORD;
+typedef uint32_t ULONG;
+typedef int32_t LONG;
+typedef LONG NTSTATUS;
+typedef LONG HRESULT;
+typedef unsigned long long ULONGLONG;
+typedef void *PVOID;
+typedef void *HANDLE;
+
+#define TRUE 1
+#define FALSE 0
+
+#define NT_SUCCESS(status) ((NTSTATUS)(status) >= 0)
+#define STATUS_SUCCESS ((NTSTATUS)0x00000000L)
+#define STATUS_UNSUCCESSFUL ((NTSTATUS)0xC0000001L)
+#define STATUS_NO_MEMORY ((NTSTATUS)0xC0000017L)
+
+typedef struct _MEMORY_BASIC_INFORMATION {
+  PVOID BaseAddress;
+  PVOID AllocationBase;
+  DWORD AllocationProtect;
+  size_t RegionSize;
+  DWORD State;
+  DWORD Protect;
+  DWORD Type;
+} MEMORY_BASIC_INFORMATION;
+
+typedef struct _MMADDRESS_NODE *PMMADDRESS_NODE;
+
+void DbgPrint(const char *format, ...);
+
+#endif  // TRAINER_DYNDXT_TOOLS_REPLAY_INCLUDE_XBOXKRNL_XBOXKRNL_H_
@@ -0,0 +1,201 @@
+// Replays a session log written by the trainer's `record start` command
+// against a memory image written by `record dump`.
+//
+// Each replayed command is written to stdout as a log line in the same format
+// as the recorder, with ticks measured in microseconds on the host, so that the
+// output of two builds can be diffed. The memory regions are mapped at their
+// original addresses so that results match those seen on the console.
+//
+// Only `search` commands are replayed; entries for other commands are skipped.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "cmd_search.h"
+#include "host_shims.h"
+#include "record_entry.h"
+
+#define kResponseBufferSize 512
+#define kContinuationBufferSize 4096
+#define kPageSize 4096
+#define kTicksPerSecond 1000000
+
+static bool LoadMemoryImage(const char *path) {
+  FILE *image = fopen(path, "rb");
+  if (!image) {
+    fprintf(stderr, "Failed to open memory image %s: %s\n", path,
+            strerror(errno));
+    return false;
+  }
+
+  uint32_t header[2];
+  while (fread(header, sizeof(header), 1, image) == 1) {
+    void *base = (void *)(uintptr_t)header[0];
+    size_t size = header[1];
+
+    // Older kernels treat MAP_FIXED_NOREPLACE as a hint, so the address must
+    // be checked as well.
+    void *mapped =
+        mmap(base, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mapped != base) {
+      fprintf(stderr, "Failed to map region 0x%08X (%zu bytes): %s\n",
+              header[0], size,
+              mapped == MAP_FAILED ? strerror(errno) : "address in use");
+      fclose(image);
+      return false;
+    }
+
+    if (fread(mapped, 1, size, image) != size) {
+      fprintf(stderr, "Truncated memory image at region 0x%08X\n", header[0]);
+      fclose(image);
+      return false;
+    }
+
+    if (!HostAddWritableRegion(mapped, size)) {
+      fprintf(stderr, "Too many regions in memory image\n");
+      fclose(image);
+      return false;
+    }
+  }
+
+  fclose(image);
+  return true;
+}
+
+// Extracts the command name and arguments from a log line, modifying the line
+// in place. Returns false if the line is not a command entry.
+static bool ParseLogLine(char *line, const char **command, const char **args) {
+  if (strncmp(line, "cmd=", 4)) {
+    return false;
+  }
+
+  *command = line + 4;
+  char *command_end = strchr(line, ' ');
+  if (!command_end) {
+    return false;
+  }
+  *command_end = 0;
+
+  char *args_start = strstr(command_end + 1, " args=\"");
+  if (!args_start) {
+    return false;
+  }
+  args_start += 7;
+
+  char *args_end = strchr(args_start, '"');
+  if (!args_end) {
+    return false;
+  }
+  *args_end = 0;
+  *args = args_start;
+  return true;
+}
+
+static uint64_t NowMicroseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * kTicksPerSecond + now.tv_nsec / 1000;
+}
+
+static void ReplaySearch(const char *args, char *response,
+                         RecordEntry *entry) {
+  char continuation_buffer[kContinuationBufferSize];
+  char continuation_response[kResponseBufferSize];
+
+  CommandContext ctx;
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.buffer = continuation_buffer;
+  ctx.buffer_size = sizeof(continuation_buffer);
+
+  *response = 0;
+  uint64_t start = NowMicroseconds();
+  HRESULT result = HandleSearch(args, response, kResponseBufferSize, &ctx);
+
+  if ((result == XBOX_S_MULTILINE || result == XBOX_S_BINARY) && ctx.handler) {
+    while (ctx.handler(&ctx, continuation_response,
+                       sizeof(continuation_response)) == XBOX_S_OK) {
+      if (result == XBOX_S_BINARY) {
+        entry->bytes += ctx.data_size;
+      } else {
+        entry->lines += RecordCountLines((const char *)ctx.buffer);
+      }
+    }
+  }
+
+  uint64_t elapsed = NowMicroseconds() - start;
+  entry->ticks = elapsed > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)elapsed;
+  entry->result = (uint32_t)result;
+}
+
+static void PrintUsage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [--pool-limit=<bytes>] <memory_image> <session_log>\n"
+          "  --pool-limit - Limit the emulated debug pool to the given size.\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  int arg = 1;
+  if (arg < argc && !strncmp(argv[arg], "--pool-limit=", 13)) {
+    HostPoolSetLimit(strtoul(argv[arg] + 13, NULL, 0));
+    ++arg;
+  }
+  if (argc - arg != 2) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  if (!LoadMemoryImage(argv[arg])) {
+    return 1;
+  }
+
+  FILE *log = fopen(argv[arg + 1], "r");
+  if (!log) {
+    fprintf(stderr, "Failed to open session log %s: %s\n", argv[arg + 1],
+            strerror(errno));
+    return 1;
+  }
+
+  char line[kRecordMaxLineLength];
+  RecordFormatHeader(line, kTicksPerSecond);
+  fputs(line, stdout);
+
+  char log_line[kRecordMaxLineLength];
+  char response[kResponseBufferSize];
+  uint32_t skipped = 0;
+  while (fgets(log_line, sizeof(log_line), log)) {
+    const char *command;
+    const char *args;
+    if (!ParseLogLine(log_line, &command, &args)) {
+      continue;
+    }
+    if (strcmp(command, "search")) {
+      ++skipped;
+      continue;
+    }
+
+    RecordEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.command = command;
+    entry.args = args;
+    entry.response = response;
+    ReplaySearch(args, response, &entry);
+    entry.pool_pages = (HostPoolBytesInUse() + kPageSize - 1) / kPageSize;
+    entry.available_pages = HostPoolBytesAvailable() / kPageSize;
+
+    RecordFormatEntry(line, &entry);
+    fputs(line, stdout);
+  }
+  fclose(log);
+
+  if (skipped) {
+    fprintf(stderr, "Skipped %u entries for commands other than search\n",
+            skipped);
+  }
+  return 0;
+}